@@ -51,41 +51,203 @@ int pieceCell(int p,int r,int x,int y){
     return TETROMINOS[p][by][bx];
 }
 
+// ------------------------------------------------------------
+// Cases occupées par chaque pièce / rotation (4 cases), précalculées
+// une fois pour que la détection de collision ne parcoure pas tout le 4x4
+// ------------------------------------------------------------
+Sint8 PIECE_CELLS[7][4][4][2];
+
+void init_piece_cells(void){
+    for(int p=0;p<7;p++)
+        for(int r=0;r<4;r++){
+            int n=0;
+            for(int y=0;y<4;y++)
+                for(int x=0;x<4;x++)
+                    if(pieceCell(p,r,x,y)){
+                        PIECE_CELLS[p][r][n][0]=(Sint8)x;
+                        PIECE_CELLS[p][r][n][1]=(Sint8)y;
+                        n++;
+                    }
+        }
+}
+
 // ------------------------------------------------------------
 // Détection collision
+// collision_on travaille sur n'importe quel plateau (partie ou solveur),
+// collision_at sur la partie en cours.
 // ------------------------------------------------------------
-int collision_at(int nx,int ny,int r){
-    for(int y=0;y<4;y++)
-        for(int x=0;x<4;x++)
-            if(pieceCell(currentPiece,r,x,y)){
-                int gx=nx+x, gy=ny+y;
-                if(gx<0||gx>=GRID_WIDTH) return 1;
-                if(gy>=GRID_HEIGHT) return 1;
-                if(gy>=0 && grid[gy][gx]) return 1;
-            }
+int collision_on(int board[GRID_HEIGHT][GRID_WIDTH],int p,int nx,int ny,int r){
+    for(int i=0;i<4;i++){
+        int gx=nx+PIECE_CELLS[p][r&3][i][0], gy=ny+PIECE_CELLS[p][r&3][i][1];
+        if(gx<0||gx>=GRID_WIDTH) return 1;
+        if(gy>=GRID_HEIGHT) return 1;
+        if(gy>=0 && board[gy][gx]) return 1;
+    }
     return 0;
 }
 
+int collision_at(int nx,int ny,int r){
+    return collision_on(grid,currentPiece,nx,ny,r);
+}
+
 // ------------------------------------------------------------
 // Verrouille la pièce dans la grille
 // ------------------------------------------------------------
+void place_piece(int board[GRID_HEIGHT][GRID_WIDTH],int p,int r,int px,int py,int packed){
+    for(int i=0;i<4;i++){
+        int gx=px+PIECE_CELLS[p][r&3][i][0], gy=py+PIECE_CELLS[p][r&3][i][1];
+        if(gy>=0 && gy<GRID_HEIGHT && gx>=0 && gx<GRID_WIDTH)
+            board[gy][gx] = packed;
+    }
+}
+
 void lockPiece(){
-    for(int y=0;y<4;y++)
-        for(int x=0;x<4;x++)
-            if(pieceCell(currentPiece,pieceRot,x,y)){
-                int gx=pieceX+x, gy=pieceY+y;
-                if(gy>=0 && gy<GRID_HEIGHT && gx>=0 && gx<GRID_WIDTH){
-                    int packed = (pieceColor[0]<<16)|(pieceColor[1]<<8)|pieceColor[2];
-                    grid[gy][gx] = packed;
-                }
-            }
+    int packed = (pieceColor[0]<<16)|(pieceColor[1]<<8)|pieceColor[2];
+    place_piece(grid,currentPiece,pieceRot,pieceX,pieceY,packed);
+}
+
+// ------------------------------------------------------------
+// Effets sonores
+// Tous les sons sont décodés (ou synthétisés) une seule fois au démarrage
+// dans un tampon alloué d'un bloc ; pendant la partie sfx_play ne fait
+// que Mix_PlayChannel : ni allocation, ni accès disque.
+// Un fichier sfx/<nom>.wav, s'il existe, remplace le son synthétisé.
+// ------------------------------------------------------------
+enum { SFX_MOVE, SFX_ROTATE, SFX_LOCK, SFX_LINE_CLEAR, SFX_GAME_OVER, SFX_COUNT };
+
+typedef struct {
+    const char *name;
+    int freqStart, freqEnd; // balayage de fréquence (Hz)
+    int durationMs;
+    int volume;             // 0..MIX_MAX_VOLUME
+} SfxTone;
+
+const SfxTone SFX_TONES[SFX_COUNT] = {
+    { "move",       440,  440,  25,  48 },
+    { "rotate",     660,  880,  35,  56 },
+    { "lock",       220,  110,  60,  80 },
+    { "line_clear", 523, 1046, 180,  96 },
+    { "game_over",  392,   98, 700, 110 },
+};
+
+#define SFX_CHANNELS 16 // canaux de mixage réservés : plusieurs effets peuvent se chevaucher
+
+int gAudioBuffer = 512;           // taille du tampon audio en échantillons (--audio-buffer)
+Mix_Chunk *gSfx[SFX_COUNT];
+Uint8 *gSfxPool = NULL;           // échantillons synthétisés de tous les effets
+int gAudioFreq = 0, gAudioChannels = 0;
+
+// mesure déclenchement -> mixage : sfx_play note l'instant (µs, 0 = rien en
+// attente) et ne le publie qu'une fois Mix_PlayChannel revenu, donc le son est
+// déjà dans le prochain tampon mixé ; le callback post-mix relève l'écart.
+// Le délai de sortie après le mixage n'est pas mesurable ici : le rapport
+// l'estime à un tampon (faux pour les pilotes qui en gardent plusieurs).
+SDL_atomic_t gSfxPending;
+Uint64 gSfxT0 = 0;
+Uint64 gLatencyCount = 0;
+double gLatencySum = 0.0, gLatencyMax = 0.0; // déclenchement -> mixage (mesuré)
+double gBufferMs = 0.0;                       // durée d'un tampon (estimation de sortie)
+
+Uint32 sfx_now_us(void){
+    double us = (double)(SDL_GetPerformanceCounter()-gSfxT0) * 1e6 / SDL_GetPerformanceFrequency();
+    return (Uint32)(Uint64)us; // repli modulo 2^32 : seules les différences comptent
+}
+
+void sfx_postmix(void *udata, Uint8 *stream, int len){
+    Uint32 t = (Uint32)SDL_AtomicSet(&gSfxPending, 0);
+    if(!t || !gAudioFreq) return;
+
+    gBufferMs = 1000.0 * len / (gAudioChannels * 2) / gAudioFreq; // 16 bits par échantillon
+    double ms = (Uint32)(sfx_now_us() - t) / 1000.0;
+    gLatencyCount++;
+    gLatencySum += ms;
+    if(ms > gLatencyMax) gLatencyMax = ms;
+}
+
+void sfx_init(void){
+    Uint16 format;
+    if(!Mix_QuerySpec(&gAudioFreq, &format, &gAudioChannels)) return; // pas d'audio : pas d'effets
+    if(format != AUDIO_S16SYS){
+        printf("Warning: format audio non géré pour les effets (0x%x)\n", format);
+        return;
+    }
+
+    // un seul bloc pour tous les effets synthétisés
+    size_t total = 0;
+    for(int i=0;i<SFX_COUNT;i++)
+        total += (size_t)gAudioFreq * SFX_TONES[i].durationMs / 1000 * gAudioChannels * sizeof(Sint16);
+    gSfxPool = malloc(total);
+
+    Mix_AllocateChannels(SFX_CHANNELS);
+
+    Uint8 *cursor = gSfxPool;
+    for(int i=0;i<SFX_COUNT;i++){
+        const SfxTone *t = &SFX_TONES[i];
+        char path[64];
+        sprintf(path, "sfx/%s.wav", t->name);
+        gSfx[i] = Mix_LoadWAV(path);
+        if(gSfx[i] || !gSfxPool) continue;
+
+        // onde carrée avec balayage linéaire et décroissance, volume géré par SDL_mixer
+        int frames = gAudioFreq * t->durationMs / 1000;
+        Sint16 *out = (Sint16 *)cursor;
+        double phase = 0.0;
+        for(int f=0;f<frames;f++){
+            double k = (double)f / frames;
+            double freq = t->freqStart + (t->freqEnd - t->freqStart) * k;
+            phase += freq / gAudioFreq;
+            if(phase >= 1.0) phase -= 1.0;
+            Sint16 v = (Sint16)((phase < 0.5 ? 1 : -1) * 12000 * (1.0 - k) * (1.0 - k));
+            for(int c=0;c<gAudioChannels;c++) *out++ = v;
+        }
+        Uint32 bytes = (Uint32)(frames * gAudioChannels * sizeof(Sint16));
+        gSfx[i] = Mix_QuickLoad_RAW(cursor, bytes);
+        cursor += bytes;
+    }
+
+    for(int i=0;i<SFX_COUNT;i++)
+        if(gSfx[i]) Mix_VolumeChunk(gSfx[i], SFX_TONES[i].volume);
+
+    gSfxT0 = SDL_GetPerformanceCounter();
+    SDL_AtomicSet(&gSfxPending, 0);
+    Mix_SetPostMix(sfx_postmix, NULL);
+}
+
+// appelable depuis n'importe quel thread (SDL_mixer verrouille l'audio)
+void sfx_play(int id){
+    if(!gSfx[id]) return;
+    Uint32 t = sfx_now_us();
+    Mix_PlayChannel(-1, gSfx[id], 0); // peut attendre la fin d'un mixage en cours
+    SDL_AtomicCAS(&gSfxPending, 0, t ? (int)t : 1); // une mesure à la fois
+}
+
+void sfx_report(void){
+    if(!gLatencyCount) return;
+    double avg = gLatencySum / gLatencyCount;
+    printf("Latence effets sonores (%s, tampon %d) : déclenchement -> mixage mesuré moyenne %.1f ms, max %.1f ms sur %llu mesures ;"
+           " sortie estimée (+1 tampon de %.1f ms, non mesuré) ~%.1f ms\n",
+           SDL_GetCurrentAudioDriver() ? SDL_GetCurrentAudioDriver() : "?", gAudioBuffer,
+           avg, gLatencyMax, (unsigned long long)gLatencyCount, gBufferMs, avg + gBufferMs);
+}
+
+// à appeler avant Mix_CloseAudio
+void sfx_free(void){
+    Mix_SetPostMix(NULL, NULL);
+    for(int i=0;i<SFX_COUNT;i++){
+        if(gSfx[i]) Mix_FreeChunk(gSfx[i]); // les chunks QuickLoad ne libèrent pas leurs échantillons
+        gSfx[i] = NULL;
+    }
+    free(gSfxPool);
+    gSfxPool = NULL;
 }
 
 // ------------------------------------------------------------
 // Suppression des lignes + ajout score (corrigée)
 // Méthode : compacte la grille en copiant (bottom-up) les lignes non-pleines.
+// remove_full_lines ne touche qu'au plateau donné et retourne le nombre de
+// lignes supprimées (réutilisé par le solveur), clearLines ajoute le score.
 // ------------------------------------------------------------
-void clearLines() {
+int remove_full_lines(int board[GRID_HEIGHT][GRID_WIDTH]) {
     int writeRow = GRID_HEIGHT - 1;
     int linesRemoved = 0;
 
@@ -93,7 +255,7 @@ void clearLines() {
         // check if readRow is full
         int full = 1;
         for(int x = 0; x < GRID_WIDTH; x++) {
-            if(grid[readRow][x] == 0) { full = 0; break; }
+            if(board[readRow][x] == 0) { full = 0; break; }
         }
 
         if(full) {
@@ -103,7 +265,7 @@ void clearLines() {
             // copy readRow to writeRow (may be same)
             if(writeRow != readRow) {
                 for(int x = 0; x < GRID_WIDTH; x++)
-                    grid[writeRow][x] = grid[readRow][x];
+                    board[writeRow][x] = board[readRow][x];
             }
             writeRow--;
         }
@@ -111,13 +273,20 @@ void clearLines() {
 
     // clear the remaining rows on top
     for(int y = writeRow; y >= 0; y--) {
-        for(int x = 0; x < GRID_WIDTH; x++) grid[y][x] = 0;
+        for(int x = 0; x < GRID_WIDTH; x++) board[y][x] = 0;
     }
 
+    return linesRemoved;
+}
+
+void clearLines() {
+    int linesRemoved = remove_full_lines(grid);
+
     // Score policy: conventional/simple (100 * number_of_lines)
     // you can change to classic Tetris scoring if you want
     if(linesRemoved > 0) {
         score += 100 * linesRemoved;
+        sfx_play(SFX_LINE_CLEAR);
     }
 }
 
@@ -143,11 +312,11 @@ void renderText(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x,
 // ------------------------------------------------------------
 // Dessine le score en haut à droite pendant la partie (TTF)
 // ------------------------------------------------------------
-void drawScore(SDL_Renderer *renderer, int winW, int winH) {
+void drawScore(SDL_Renderer *renderer, int winW, int winH, int shownScore) {
     if(!gFont) return;
 
     char buffer[128];
-    sprintf(buffer, "%s - SCORE: %d", playerName, score);
+    sprintf(buffer, "%s - SCORE: %d", playerName, shownScore);
     renderText(renderer, gFont, buffer, 20, 12);
 
     // taille font adaptative
@@ -268,7 +437,6 @@ void afficher_game_over(SDL_Renderer *renderer,int winW,int winH){
 
     SDL_RenderPresent(renderer);
     SDL_Delay(3500);
-    exit(0);
 }
 void ask_player_name(SDL_Window *window, SDL_Renderer *renderer) {
     SDL_Event e;
@@ -317,33 +485,697 @@ void ask_player_name(SDL_Window *window, SDL_Renderer *renderer) {
     SDL_StopTextInput();
 }
 
+// ------------------------------------------------------------
+// Générateur de pièces
+// PRNG splitmix64 à état explicite (reproductible avec --seed), mode
+// aléatoire pur ou sac de 7 (--bag), et file circulaire des prochaines
+// pièces remplie par lots de GEN_BATCH pour l'aperçu à l'écran.
+// ------------------------------------------------------------
+enum { GEN_RANDOM, GEN_BAG };
+
+#define PREVIEW_COUNT  5  // pièces affichées à l'avance
+#define GEN_BATCH      7  // un sac complet par remplissage
+#define GEN_QUEUE_SIZE 16 // puissance de 2, >= PREVIEW_COUNT + GEN_BATCH
+#define PREVIEW_COLS   3  // colonnes (en cases de grille) réservées à l'aperçu
+
+typedef struct {
+    Uint64 state;                // état du PRNG des pièces
+    Uint64 colorState;           // flux séparé pour les couleurs : les pièces ne dépendent que de la graine
+    int mode;                    // GEN_RANDOM ou GEN_BAG
+    Uint8 queue[GEN_QUEUE_SIZE];
+    unsigned head, count;        // file circulaire
+} PieceGen;
+
+PieceGen gGen;
+
+// générateur splitmix64 : petit, rapide, état explicite
+Uint64 splitmix64(Uint64 *state){
+    Uint64 z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// entier dans [0, n) par multiplication (pas de modulo ni de biais notable)
+int gen_below(PieceGen *g,int n){
+    return (int)(((splitmix64(&g->state) >> 32) * (Uint64)n) >> 32);
+}
+
+void gen_refill(PieceGen *g){
+    while(g->count + GEN_BATCH <= GEN_QUEUE_SIZE){
+        Uint8 batch[GEN_BATCH];
+        if(g->mode == GEN_BAG){
+            // sac de 7 mélangé (Fisher-Yates) : chaque pièce une fois par lot
+            for(int i=0;i<GEN_BATCH;i++) batch[i] = (Uint8)i;
+            for(int i=GEN_BATCH-1;i>0;i--){
+                int j = gen_below(g,i+1);
+                Uint8 t = batch[i]; batch[i] = batch[j]; batch[j] = t;
+            }
+        } else {
+            for(int i=0;i<GEN_BATCH;i++) batch[i] = (Uint8)gen_below(g,7);
+        }
+        for(int i=0;i<GEN_BATCH;i++)
+            g->queue[(g->head + g->count++) & (GEN_QUEUE_SIZE-1)] = batch[i];
+    }
+}
+
+void gen_init(PieceGen *g,int mode,Uint64 seed){
+    g->state = seed;
+    Uint64 derive = seed ^ 0xC0104C0104ull;
+    g->colorState = splitmix64(&derive);
+    g->mode = mode;
+    g->head = 0;
+    g->count = 0;
+    gen_refill(g);
+}
+
+// retire la prochaine pièce de la file
+int gen_next(PieceGen *g){
+    if(g->count <= PREVIEW_COUNT) gen_refill(g);
+    int p = g->queue[g->head];
+    g->head = (g->head + 1) & (GEN_QUEUE_SIZE-1);
+    g->count--;
+    return p;
+}
+
+// i-ème pièce à venir (0 = la prochaine), i < PREVIEW_COUNT
+int gen_peek(const PieceGen *g,int i){
+    return g->queue[(g->head + i) & (GEN_QUEUE_SIZE-1)];
+}
+
 // ------------------------------------------------------------
 // Génère une nouvelle pièce
+// Retourne 0 si elle ne peut pas apparaître (game over) : c'est le thread
+// principal qui affiche l'écran de fin, la simulation ne touche pas au renderer.
 // ------------------------------------------------------------
-void spawn_new_piece(SDL_Renderer *renderer,int winW,int winH){
-    currentPiece=rand()%7;
+int spawn_new_piece(void){
+    currentPiece=gen_next(&gGen);
     pieceRot=0; pieceX=3; pieceY=-1;
-    pieceColor[0]=rand()%200; pieceColor[1]=rand()%200; pieceColor[2]=rand()%200;
+    Uint64 c=splitmix64(&gGen.colorState); // un seul tirage pour les 3 composantes (0..199)
+    pieceColor[0]=(int)(((c>>8)&0xFF)*200>>8); pieceColor[1]=(int)(((c>>16)&0xFF)*200>>8); pieceColor[2]=(int)(((c>>24)&0xFF)*200>>8);
 
-    if(collision_at(pieceX,pieceY,pieceRot)) afficher_game_over(renderer,winW,winH);
+    return !collision_at(pieceX,pieceY,pieceRot);
 }
 
 // ------------------------------------------------------------
 // Rotation avec kicks
 // ------------------------------------------------------------
-int try_rotate_with_kick(int winW,int winH,SDL_Renderer *renderer){
-    int newR=(pieceRot+1)&3;
+int rotate_with_kick_on(int board[GRID_HEIGHT][GRID_WIDTH],int p,int *px,int py,int *pr){
+    int newR=(*pr+1)&3;
     int kicks[]={0,-1,1,-2,2};
     for(int i=0;i<5;i++){
-        int nx=pieceX+kicks[i];
-        if(!collision_at(nx,pieceY,newR)){
-            pieceX=nx; pieceRot=newR;
+        int nx=*px+kicks[i];
+        if(!collision_on(board,p,nx,py,newR)){
+            *px=nx; *pr=newR;
             return 1;
         }
     }
     return 0;
 }
 
+int try_rotate_with_kick(void){
+    return rotate_with_kick_on(grid,currentPiece,&pieceX,pieceY,&pieceRot);
+}
+
+// ------------------------------------------------------------
+// File d'entrées lock-free (un producteur / un consommateur)
+// Le thread principal (événements SDL) pousse les commandes avec l'instant
+// de la touche, le thread de simulation les dépile. Aucun verrou : head
+// n'est écrit que par le consommateur, tail que par le producteur.
+// ------------------------------------------------------------
+enum { INPUT_LEFT, INPUT_RIGHT, INPUT_DOWN, INPUT_ROTATE, INPUT_DROP };
+
+#define INPUT_QUEUE_SIZE 64 // puissance de 2 (masque au lieu d'un modulo)
+
+typedef struct {
+    Uint8 cmd;
+    Uint32 time; // e.key.timestamp (ms, même horloge que SDL_GetTicks)
+} InputEvent;
+
+typedef struct {
+    InputEvent events[INPUT_QUEUE_SIZE];
+    SDL_atomic_t head; // prochaine case à lire (consommateur)
+    SDL_atomic_t tail; // prochaine case à écrire (producteur)
+} InputQueue;
+
+int input_push(InputQueue *q, Uint8 cmd, Uint32 time){
+    unsigned tail = (unsigned)SDL_AtomicGet(&q->tail);
+    unsigned head = (unsigned)SDL_AtomicGet(&q->head);
+    if(tail - head >= INPUT_QUEUE_SIZE) return 0; // file pleine : la touche est perdue
+
+    q->events[tail & (INPUT_QUEUE_SIZE-1)].cmd = cmd;
+    q->events[tail & (INPUT_QUEUE_SIZE-1)].time = time;
+    SDL_MemoryBarrierRelease(); // la commande est visible avant le nouveau tail
+    SDL_AtomicSet(&q->tail, (int)(tail + 1));
+    return 1;
+}
+
+int input_pop(InputQueue *q, InputEvent *ev){
+    unsigned head = (unsigned)SDL_AtomicGet(&q->head);
+    unsigned tail = (unsigned)SDL_AtomicGet(&q->tail);
+    if(head == tail) return 0; // file vide
+
+    SDL_MemoryBarrierAcquire(); // lit la commande publiée avec ce tail
+    *ev = q->events[head & (INPUT_QUEUE_SIZE-1)];
+    SDL_AtomicSet(&q->head, (int)(head + 1));
+    return 1;
+}
+
+// ------------------------------------------------------------
+// Triple buffer d'états du plateau (simulation -> rendu)
+// La simulation écrit toujours dans "back" puis l'échange avec "middle" ;
+// le rendu échange "front" avec "middle" seulement si un état neuf est
+// arrivé. Chaque côté garde sa case à lui : pas de verrou, pas d'attente,
+// et le rendu voit toujours un état complet (jamais à moitié écrit).
+// ------------------------------------------------------------
+typedef struct {
+    int grid[GRID_HEIGHT][GRID_WIDTH];
+    int piece, rot, x, y;
+    int color[3];
+    int next[PREVIEW_COUNT]; // aperçu des prochaines pièces
+    int score;
+    int gameOver;
+} BoardSnapshot;
+
+#define SNAPSHOT_FRESH 4 // bit ajouté à l'index de "middle" quand il n'a pas encore été lu
+
+typedef struct {
+    BoardSnapshot slots[3];
+    SDL_atomic_t middle; // index de la case du milieu | SNAPSHOT_FRESH
+    int back;            // à la simulation
+    int front;           // au rendu
+} TripleBuffer;
+
+void triple_buffer_init(TripleBuffer *tb){
+    memset(tb->slots, 0, sizeof(tb->slots));
+    tb->back = 0;
+    tb->front = 2;
+    SDL_AtomicSet(&tb->middle, 1);
+}
+
+// copie l'état courant de la partie dans la case "back" puis la publie
+void publish_snapshot(TripleBuffer *tb, int gameOver){
+    BoardSnapshot *s = &tb->slots[tb->back];
+    memcpy(s->grid, grid, sizeof(grid));
+    s->piece = currentPiece; s->rot = pieceRot; s->x = pieceX; s->y = pieceY;
+    s->color[0] = pieceColor[0]; s->color[1] = pieceColor[1]; s->color[2] = pieceColor[2];
+    for(int i=0;i<PREVIEW_COUNT;i++) s->next[i] = gen_peek(&gGen,i);
+    s->score = score;
+    s->gameOver = gameOver;
+
+    SDL_MemoryBarrierRelease();
+    tb->back = SDL_AtomicSet(&tb->middle, tb->back | SNAPSHOT_FRESH) & 3;
+}
+
+// retourne le dernier état publié (ou le précédent si rien de neuf)
+const BoardSnapshot *acquire_snapshot(TripleBuffer *tb){
+    if(SDL_AtomicGet(&tb->middle) & SNAPSHOT_FRESH){
+        tb->front = SDL_AtomicSet(&tb->middle, tb->front) & 3;
+        SDL_MemoryBarrierAcquire();
+    }
+    return &tb->slots[tb->front];
+}
+
+// ------------------------------------------------------------
+// Thread de simulation : entrées, gravité, verrouillage
+// Il possède seul grid / currentPiece / score pendant la partie, donc un
+// SDL_RenderPresent lent ou un rendu TTF ne retarde plus la chute des pièces.
+// ------------------------------------------------------------
+InputQueue gInput;
+TripleBuffer gSnapshots;
+SDL_atomic_t gSimQuit;
+
+// verrouille la pièce, efface les lignes et fait apparaître la suivante
+// retourne 0 en cas de game over
+int lock_and_spawn(void){
+    lockPiece();
+    sfx_play(SFX_LOCK);
+    clearLines();
+    if(spawn_new_piece()) return 1;
+    sfx_play(SFX_GAME_OVER);
+    return 0;
+}
+
+// applique les pas de gravité dus avant l'instant now (ms) ; une touche
+// horodatée avant un pas de gravité est ainsi traitée avant lui, même si la
+// simulation l'a reçue en retard. Retourne 1 si l'état a changé.
+int gravity_until(Uint32 now, Uint32 *lastFall, int *alive){
+    int changed=0;
+    for(;;){
+        int fallDelay = 500 - (score / 500) * 50; // chaque fois qu'il y a 500 points on accélère de 50ms
+        if (fallDelay < 100) fallDelay = 100;  // limite minimale : 100ms
+
+        if(!*alive || (Sint32)(now - *lastFall) <= fallDelay) return changed;
+        *lastFall += (Uint32)fallDelay;
+        if(!collision_at(pieceX,pieceY+1,pieceRot)) pieceY++;
+        else *alive = lock_and_spawn();
+        changed=1;
+    }
+}
+
+int simulation_thread(void *data){
+    (void)data;
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+
+    Uint32 lastFall=SDL_GetTicks();
+    int alive=1;
+
+    while(alive && !SDL_AtomicGet(&gSimQuit)){
+        int changed=0;
+        InputEvent ev;
+
+        while(alive && input_pop(&gInput,&ev)){
+            changed |= gravity_until(ev.time,&lastFall,&alive);
+            if(!alive) break;
+
+            changed=1;
+            switch(ev.cmd){
+                case INPUT_LEFT:
+                    if(!collision_at(pieceX-1,pieceY,pieceRot)){ pieceX--; sfx_play(SFX_MOVE); }
+                    break;
+                case INPUT_RIGHT:
+                    if(!collision_at(pieceX+1,pieceY,pieceRot)){ pieceX++; sfx_play(SFX_MOVE); }
+                    break;
+                case INPUT_DOWN:
+                    if(!collision_at(pieceX,pieceY+1,pieceRot)){ pieceY++; sfx_play(SFX_MOVE); }
+                    break;
+                case INPUT_ROTATE:
+                    if(try_rotate_with_kick()) sfx_play(SFX_ROTATE);
+                    break;
+                case INPUT_DROP: //chute instantanée puis verrouillage + nouvelle pièce
+                    while(!collision_at(pieceX,pieceY+1,pieceRot)) pieceY++;
+                    alive = lock_and_spawn();
+                    if((Sint32)(ev.time - lastFall) > 0) lastFall=ev.time;
+                    break;
+            }
+        }
+
+        changed |= gravity_until(SDL_GetTicks(),&lastFall,&alive);
+
+        if(changed) publish_snapshot(&gSnapshots, !alive);
+        SDL_Delay(1);
+    }
+    return 0;
+}
+
+// ------------------------------------------------------------
+// SOLVEUR DE PUZZLES / PERFECT CLEAR (outil hors-ligne)
+// Recherche en profondeur sur les placements atteignables depuis
+// l'apparition, avec les mêmes règles que la partie (collision_on,
+// rotate_with_kick_on, remove_full_lines). Les états déjà explorés sans
+// succès sont mémorisés par hachage de Zobrist dans une table de
+// transposition de taille fixe : la mémoire reste bornée.
+// ------------------------------------------------------------
+#define SOLVER_MAX_PIECES 32
+#define SOLVER_MAX_LINES  (SOLVER_MAX_PIECES*4/GRID_WIDTH + 1)
+#define SOLVER_TT_BITS    20 // 1M entrées de 8 octets = 8 Mo
+
+// positions explorées : x dans [-3, GRID_WIDTH+2], y dans [-1, GRID_HEIGHT+2]
+#define SOLVER_X_OFF 3
+#define SOLVER_Y_OFF 1
+#define SOLVER_XS    (GRID_WIDTH+6)
+#define SOLVER_YS    (GRID_HEIGHT+4)
+#define SOLVER_MAX_POS (SOLVER_XS*SOLVER_YS*4)
+
+enum { GOAL_LINES, GOAL_PERFECT_CLEAR };
+
+const char PIECE_NAMES[7] = { 'I','O','T','J','L','S','Z' };
+
+typedef struct { Sint8 x, y, r; } Placement;
+
+typedef struct {
+    int pieces[SOLVER_MAX_PIECES];
+    int count;            // nombre de pièces de la séquence
+    int goal;             // GOAL_LINES ou GOAL_PERFECT_CLEAR
+    int targetLines;      // pour GOAL_LINES
+    Uint64 maxNodes;      // 0 = pas de limite
+    Uint64 nodes;         // états développés
+    Uint64 *table;        // table de transposition (clés des échecs)
+    Placement solution[SOLVER_MAX_PIECES];
+    int solutionLen;
+} Solver;
+
+Uint64 zobristCell[GRID_HEIGHT][GRID_WIDTH];
+Uint64 zobristDepth[SOLVER_MAX_PIECES+1];
+Uint64 zobristLines[SOLVER_MAX_LINES+1];
+
+void zobrist_init(void){
+    Uint64 seed = 0x5EED7E7215ull; // fixe : les clés sont reproductibles
+    for(int y=0;y<GRID_HEIGHT;y++)
+        for(int x=0;x<GRID_WIDTH;x++) zobristCell[y][x] = splitmix64(&seed);
+    for(int d=0;d<=SOLVER_MAX_PIECES;d++) zobristDepth[d] = splitmix64(&seed);
+    for(int l=0;l<=SOLVER_MAX_LINES;l++) zobristLines[l] = splitmix64(&seed);
+}
+
+int row_has_hole(const int row[GRID_WIDTH]){
+    for(int x=0;x<GRID_WIDTH;x++) if(!row[x]) return 1;
+    return 0;
+}
+
+// hachage de Zobrist des cases pleines, nombre de cases et hauteur de la
+// pile en un seul passage ; utilisé à la racine et après un effacement de
+// lignes, sinon le hachage est mis à jour case par case
+void solver_scan(int board[GRID_HEIGHT][GRID_WIDTH],Uint64 *key,int *cells,int *height){
+    *key = 0; *cells = 0; *height = 0;
+    for(int y=0;y<GRID_HEIGHT;y++)
+        for(int x=0;x<GRID_WIDTH;x++)
+            if(board[y][x]){
+                *key ^= zobristCell[y][x];
+                (*cells)++;
+                if(*height < GRID_HEIGHT-y) *height = GRID_HEIGHT-y;
+            }
+}
+
+// énumère les positions de verrouillage atteignables (gauche, droite,
+// bas, rotation avec kicks) par un parcours en largeur depuis l'apparition
+int solver_placements(int board[GRID_HEIGHT][GRID_WIDTH],int p,Placement *out){
+    static Uint16 seen[SOLVER_MAX_POS]; // == stamp : déjà visité pendant ce parcours
+    static Uint16 stamp = 0;
+    static Placement queue[SOLVER_MAX_POS];
+    int head=0, tail=0, n=0;
+
+    if(collision_on(board,p,3,-1,0)) return 0; // la pièce ne peut même pas apparaître
+    if(++stamp == 0){ memset(seen,0,sizeof(seen)); stamp = 1; } // pas de remise à zéro à chaque parcours
+
+    #define SOLVER_POS(X,Y,R) ((((Y)+SOLVER_Y_OFF)*SOLVER_XS + (X)+SOLVER_X_OFF)*4 + (R))
+    seen[SOLVER_POS(3,-1,0)] = stamp;
+    queue[tail++] = (Placement){ 3, -1, 0 };
+
+    while(head<tail){
+        Placement c = queue[head++];
+        int x=c.x, y=c.y, r=c.r;
+        Placement next[4];
+        int nn=0;
+
+        if(!collision_on(board,p,x-1,y,r)) next[nn++] = (Placement){ x-1, y, r };
+        if(!collision_on(board,p,x+1,y,r)) next[nn++] = (Placement){ x+1, y, r };
+        if(!collision_on(board,p,x,y+1,r)) next[nn++] = (Placement){ x, y+1, r };
+        else out[n++] = c; // ne peut plus descendre : position de verrouillage
+
+        int rx=x, rr=r;
+        if(rotate_with_kick_on(board,p,&rx,y,&rr)) next[nn++] = (Placement){ rx, y, rr };
+
+        for(int i=0;i<nn;i++){
+            int idx = SOLVER_POS(next[i].x,next[i].y,next[i].r);
+            if(seen[idx] != stamp){ seen[idx]=stamp; queue[tail++]=next[i]; }
+        }
+    }
+    #undef SOLVER_POS
+    return n;
+}
+
+// perfect clear encore possible ? il faut m <= remaining pièces telles que
+// cells + 4m remplisse exactement L lignes, avec L au moins égal à la
+// hauteur de la pile (une ligne effacée ne fait que descendre celles du dessus)
+int pc_reachable(int cells,int height,int remaining){
+    for(int m=0;m<=remaining;m++){
+        int total = cells + 4*m;
+        if(total > 0 && total % GRID_WIDTH == 0 && total/GRID_WIDTH >= height) return 1;
+    }
+    return 0;
+}
+
+// boardKey, cells et height décrivent board (voir solver_scan) ; la pièce
+// est posée puis retirée sur place tant qu'aucune ligne n'est complète,
+// le plateau n'est copié que lorsqu'il faut effacer des lignes
+int solver_dfs(Solver *s,int board[GRID_HEIGHT][GRID_WIDTH],int depth,int lines,
+               Uint64 boardKey,int cells,int height){
+    if(depth >= s->count) return 0;
+    if(s->maxNodes && s->nodes >= s->maxNodes) return 0;
+    if(s->goal == GOAL_PERFECT_CLEAR && !pc_reachable(cells, height, s->count-depth)) return 0;
+
+    Uint64 key = boardKey ^ zobristDepth[depth] ^ zobristLines[lines];
+    if(!key) key = 1; // 0 marque une case vide de la table
+    Uint64 *slot = &s->table[key & ((1u<<SOLVER_TT_BITS)-1)];
+    if(*slot == key) return 0; // état déjà exploré sans succès
+    s->nodes++;
+
+    Placement moves[SOLVER_MAX_POS];
+    int p = s->pieces[depth];
+    int n = solver_placements(board,p,moves);
+
+    for(int i=0;i<n;i++){
+        Placement m = moves[i];
+        Uint64 childKey = boardKey;
+        int placed=0, top=GRID_HEIGHT, full=0;
+
+        for(int k=0;k<4;k++){
+            int gy = m.y + PIECE_CELLS[p][m.r][k][1];
+            int gx = m.x + PIECE_CELLS[p][m.r][k][0];
+            if(gy < 0) continue; // hors de la grille : place_piece l'ignore aussi
+            childKey ^= zobristCell[gy][gx];
+            placed++;
+            if(gy < top) top = gy;
+        }
+        place_piece(board,p,m.r,m.x,m.y,p+1);
+
+        // une ligne ne peut se compléter que sur les rangées touchées par la pièce
+        for(int k=0;k<4 && !full;k++){
+            int gy = m.y + PIECE_CELLS[p][m.r][k][1];
+            if(gy >= 0 && gy < GRID_HEIGHT && !row_has_hole(board[gy])) full=1;
+        }
+
+        s->solution[depth] = m;
+        int found;
+        if(!full){
+            int childHeight = (GRID_HEIGHT-top > height) ? GRID_HEIGHT-top : height;
+            found = solver_dfs(s,board,depth+1,lines,childKey,cells+placed,childHeight);
+            place_piece(board,p,m.r,m.x,m.y,0); // retire la pièce : le plateau redevient celui du parent
+        } else {
+            int child[GRID_HEIGHT][GRID_WIDTH];
+            memcpy(child,board,sizeof(child));
+            place_piece(board,p,m.r,m.x,m.y,0);
+
+            int cleared = remove_full_lines(child);
+            int total = lines + cleared;
+            if(total > SOLVER_MAX_LINES) total = SOLVER_MAX_LINES;
+
+            int childCells, childHeight;
+            solver_scan(child,&childKey,&childCells,&childHeight);
+            int done = (s->goal == GOAL_LINES) ? (total >= s->targetLines) : (childCells == 0);
+            if(done){ s->solutionLen = depth+1; return 1; }
+            found = solver_dfs(s,child,depth+1,total,childKey,childCells,childHeight);
+        }
+        if(found) return 1;
+    }
+
+    if(!s->maxNodes || s->nodes < s->maxNodes) *slot = key; // échec complet uniquement (toujours remplacer)
+    return 0;
+}
+
+// retourne 1 si une solution a été trouvée (dans s->solution)
+int solver_run(Solver *s,int board[GRID_HEIGHT][GRID_WIDTH]){
+    Uint64 key;
+    int cells, height;
+    s->nodes = 0;
+    s->solutionLen = 0;
+    memset(s->table,0,sizeof(Uint64)<<SOLVER_TT_BITS);
+    solver_scan(board,&key,&cells,&height);
+    return solver_dfs(s,board,0,0,key,cells,height);
+}
+
+// lit un plateau texte : une ligne par rangée, '.' vide, autre caractère plein,
+// les rangées sont alignées sur le bas de la grille
+int load_board(const char *path,int board[GRID_HEIGHT][GRID_WIDTH]){
+    FILE *f = fopen(path,"r");
+    if(!f){ printf("Erreur : impossible d'ouvrir %s\n", path); return 0; }
+
+    char rows[GRID_HEIGHT][GRID_WIDTH+1];
+    char line[256];
+    int n=0;
+    while(fgets(line,sizeof(line),f)){
+        line[strcspn(line,"\r\n")] = '\0';
+        if(line[0]=='\0') continue;
+        if(n>=GRID_HEIGHT || (int)strlen(line)!=GRID_WIDTH){
+            printf("Erreur : %s doit contenir au plus %d lignes de %d caractères\n", path, GRID_HEIGHT, GRID_WIDTH);
+            fclose(f);
+            return 0;
+        }
+        strcpy(rows[n++],line);
+    }
+    fclose(f);
+
+    memset(board,0,sizeof(int)*GRID_HEIGHT*GRID_WIDTH);
+    for(int i=0;i<n;i++)
+        for(int x=0;x<GRID_WIDTH;x++)
+            board[GRID_HEIGHT-n+i][x] = (rows[i][x] != '.') ? 0xFFFFFF : 0;
+    return 1;
+}
+
+// "IOTJ..." -> indices de TETROMINOS
+int parse_pieces(const char *text,Solver *s){
+    s->count = 0;
+    for(const char *c=text; *c; c++){
+        const char *hit = memchr(PIECE_NAMES, *c & ~0x20, sizeof(PIECE_NAMES)); // insensible à la casse
+        if(!hit || s->count>=SOLVER_MAX_PIECES){
+            printf("Erreur : séquence de pièces invalide '%s' (lettres IOTJLSZ, %d max)\n", text, SOLVER_MAX_PIECES);
+            return 0;
+        }
+        s->pieces[s->count++] = (int)(hit - PIECE_NAMES);
+    }
+    return s->count > 0;
+}
+
+int row_empty(const int row[GRID_WIDTH]){
+    for(int x=0;x<GRID_WIDTH;x++) if(row[x]) return 0;
+    return 1;
+}
+
+void print_board(int board[GRID_HEIGHT][GRID_WIDTH]){
+    int top=0;
+    while(top<GRID_HEIGHT-1 && row_empty(board[top])) top++; // saute les rangées vides du haut
+    for(int y=top;y<GRID_HEIGHT;y++){
+        for(int x=0;x<GRID_WIDTH;x++) putchar(board[y][x] ? '#' : '.');
+        putchar('\n');
+    }
+}
+
+void print_solution(Solver *s,int board[GRID_HEIGHT][GRID_WIDTH]){
+    int b[GRID_HEIGHT][GRID_WIDTH];
+    memcpy(b,board,sizeof(b));
+    for(int i=0;i<s->solutionLen;i++){
+        Placement m = s->solution[i];
+        printf("%2d. %c  rotation=%d  x=%d  y=%d\n", i+1, PIECE_NAMES[s->pieces[i]], m.r, m.x, m.y);
+        place_piece(b,s->pieces[i],m.r,m.x,m.y,1);
+        remove_full_lines(b);
+    }
+    printf("Plateau final :\n");
+    print_board(b);
+}
+
+// ------------------------------------------------------------
+// Ligne de commande : ./main --solve <plateau.txt> <pièces> [--pc | --lines N] [--max-nodes N]
+// ------------------------------------------------------------
+int solver_main(int argc,char *argv[]){
+    if(argc<4){
+        printf("Usage : %s --solve <plateau.txt> <pieces> [--pc | --lines N] [--max-nodes N]\n", argv[0]);
+        return 2;
+    }
+
+    static Solver s;
+    int board[GRID_HEIGHT][GRID_WIDTH];
+    memset(&s,0,sizeof(s));
+    s.goal = GOAL_PERFECT_CLEAR;
+
+    if(!load_board(argv[2],board) || !parse_pieces(argv[3],&s)) return 2;
+
+    for(int i=4;i<argc;i++){
+        if(strcmp(argv[i],"--pc")==0) s.goal = GOAL_PERFECT_CLEAR;
+        else if(strcmp(argv[i],"--lines")==0 && i+1<argc){
+            s.goal = GOAL_LINES;
+            s.targetLines = atoi(argv[++i]);
+            if(s.targetLines<1 || s.targetLines>SOLVER_MAX_LINES){
+                printf("Erreur : --lines doit être entre 1 et %d\n", SOLVER_MAX_LINES);
+                return 2;
+            }
+        }
+        else if(strcmp(argv[i],"--max-nodes")==0 && i+1<argc) s.maxNodes = strtoull(argv[++i],NULL,10);
+        else { printf("Erreur : option inconnue %s\n", argv[i]); return 2; }
+    }
+
+    s.table = malloc(sizeof(Uint64)<<SOLVER_TT_BITS);
+    if(!s.table){ printf("Erreur : mémoire insuffisante pour la table de transposition\n"); return 2; }
+    zobrist_init();
+
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    int found = solver_run(&s,board);
+    double sec = (double)(SDL_GetPerformanceCounter()-t0) / SDL_GetPerformanceFrequency();
+
+    if(found) print_solution(&s,board);
+    else if(s.maxNodes && s.nodes>=s.maxNodes) printf("Aucune solution trouvée (limite de %llu noeuds atteinte)\n", (unsigned long long)s.maxNodes);
+    else printf("Aucune solution\n");
+    printf("%llu noeuds en %.3f s (%.0f noeuds/s)\n", (unsigned long long)s.nodes, sec, sec>0 ? s.nodes/sec : 0.0);
+
+    free(s.table);
+    return found ? 0 : 1;
+}
+
+// ------------------------------------------------------------
+// Benchmark : ./main --bench-solver
+// Perfect clear 4 lignes sur plateau vide avec une séquence fixe qui a une
+// solution (trouvée en ~72k noeuds) : le débit mesuré couvre une recherche
+// réussie ; la borne en noeuds garde la mesure comparable si l'ordre change.
+// ------------------------------------------------------------
+int solver_bench(void){
+    static Solver s;
+    int board[GRID_HEIGHT][GRID_WIDTH];
+    memset(&s,0,sizeof(s));
+    memset(board,0,sizeof(board));
+    parse_pieces("IJLOSZTIJL",&s);
+    s.goal = GOAL_PERFECT_CLEAR;
+    s.maxNodes = 100000;
+
+    s.table = malloc(sizeof(Uint64)<<SOLVER_TT_BITS);
+    if(!s.table){ printf("Erreur : mémoire insuffisante pour la table de transposition\n"); return 2; }
+    zobrist_init();
+
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    int found = solver_run(&s,board);
+    double sec = (double)(SDL_GetPerformanceCounter()-t0) / SDL_GetPerformanceFrequency();
+
+    printf("bench-solver : %s, %llu noeuds en %.3f s -> %.0f noeuds/s\n",
+           found ? "solution" : "pas de solution", (unsigned long long)s.nodes, sec, sec>0 ? s.nodes/sec : 0.0);
+
+    free(s.table);
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Mesure de latence : ./main --sfx-latency [--audio-buffer N]
+// Sans fenêtre ; fonctionne avec SDL_AUDIODRIVER=dummy ou disk.
+// ------------------------------------------------------------
+int sfx_latency_main(void){
+    if(SDL_Init(SDL_INIT_AUDIO)!=0){
+        printf("Erreur SDL : %s\n", SDL_GetError());
+        return 1;
+    }
+    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, gAudioBuffer) < 0){
+        printf("Erreur audio (Mix_OpenAudio) : %s\n", Mix_GetError());
+        SDL_Quit();
+        return 1;
+    }
+    sfx_init();
+
+    // chaque effet plusieurs fois, espacés pour que chaque mesure tombe dans son propre tampon
+    for(int n=0;n<20;n++)
+        for(int i=0;i<SFX_COUNT;i++){
+            sfx_play(i);
+            SDL_Delay(40);
+        }
+    SDL_Delay(200);
+
+    sfx_free();
+    Mix_CloseAudio();
+    if(!gLatencyCount) printf("Aucune mesure (audio indisponible ?)\n");
+    sfx_report();
+    SDL_Quit();
+    return gLatencyCount ? 0 : 1;
+}
+
+// ------------------------------------------------------------
+// Benchmark : ./main --bench-gen [--bag | --random] [--seed N]
+// Débit du générateur comparé à l'ancien tirage rand()%7.
+// ------------------------------------------------------------
+int gen_bench(int mode,Uint64 seed){
+    const int N = 50000000;
+    PieceGen g;
+    Uint64 sum = 0; // empêche le compilateur de supprimer les boucles
+
+    gen_init(&g,mode,seed);
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    for(int i=0;i<N;i++) sum += (Uint64)gen_next(&g);
+    double sec = (double)(SDL_GetPerformanceCounter()-t0) / SDL_GetPerformanceFrequency();
+
+    srand((unsigned)seed);
+    t0 = SDL_GetPerformanceCounter();
+    for(int i=0;i<N;i++) sum += (Uint64)(rand()%7);
+    double secRand = (double)(SDL_GetPerformanceCounter()-t0) / SDL_GetPerformanceFrequency();
+
+    printf("bench-gen (%s) : %d pièces en %.3f s -> %.1f M pièces/s (rand()%%7 : %.1f M/s) [%llu]\n",
+           mode == GEN_BAG ? "sac de 7" : "aléatoire", N, sec, N/sec/1e6, N/secRand/1e6, (unsigned long long)sum);
+    return 0;
+}
+
 // ------------------------------------------------------------
 // MENU PRINCIPAL (garde ton ASCII title/button)
 // ------------------------------------------------------------
@@ -534,11 +1366,117 @@ int menu(SDL_Window *window, SDL_Renderer *renderer, int winW, int winH){
     return 1;
 }
 
+// ------------------------------------------------------------
+// Dessine une image de la partie à partir d'un état publié
+// ------------------------------------------------------------
+void draw_game(SDL_Renderer *renderer, int winW, int winH, const BoardSnapshot *snap){
+    int cols=GRID_WIDTH+PREVIEW_COLS; // la grille + les colonnes de l'aperçu
+    float tile=(winH/(float)GRID_HEIGHT < winW/(float)cols)? winH/(float)GRID_HEIGHT : winW/(float)cols; // calcule la taille d'une case / s'adapte à la fenêtre 
+
+    float offsetX=(winW - tile*cols)/2.0f; //centre la grille et l'aperçu 
+    float offsetY=(winH - tile*GRID_HEIGHT)/2.0f;
+
+    SDL_SetRenderDrawColor(renderer,0,0,0,255); // couleur de fond
+    SDL_RenderClear(renderer); //efface l'écran avec la couleur définie juste avant
+
+    // Grille
+    for(int gy=0; gy<GRID_HEIGHT; gy++){
+        for(int gx=0; gx<GRID_WIDTH; gx++){
+            SDL_Rect cell={
+                (int)(offsetX+gx*tile),
+                (int)(offsetY+gy*tile),
+                (int)(tile+0.5f),
+                (int)(tile+0.5f)
+            };
+
+            if(snap->grid[gy][gx]){
+                int packed=snap->grid[gy][gx];
+                int r=(packed>>16)&0xFF, g=(packed>>8)&0xFF, b=packed&0xFF;
+                SDL_SetRenderDrawColor(renderer,r,g,b,255); //couleur aléatoire pour les pièces 
+                SDL_RenderFillRect(renderer,&cell); //dessine un rectangle plein à la position et taille décrites par cell
+
+                // dessine une bordure fine autour du bloc
+                SDL_SetRenderDrawColor(renderer,0,0,0,200);
+                SDL_RenderDrawRect(renderer,&cell);
+            } else {
+                SDL_SetRenderDrawColor(renderer,50,50,50,255);
+                SDL_RenderDrawRect(renderer,&cell);
+            }
+        }
+    }
+
+    // Pièce active
+    int rcol=snap->color[0], gcol=snap->color[1], bcol=snap->color[2];
+    SDL_SetRenderDrawColor(renderer,rcol,gcol,bcol,255);
+
+    for(int y=0;y<4;y++)
+        for(int x=0;x<4;x++)
+            if(pieceCell(snap->piece,snap->rot,x,y)){
+                int gx=snap->x+x, gy=snap->y+y;
+                // only draw visible cells (gy might be negative)
+                if(gy >= 0 && gy < GRID_HEIGHT){
+                    SDL_Rect cell={
+                        (int)(offsetX+gx*tile),
+                        (int)(offsetY+gy*tile),
+                        (int)(tile+0.5f),
+                        (int)(tile+0.5f)
+                    };
+                    SDL_RenderFillRect(renderer,&cell);
+                    SDL_SetRenderDrawColor(renderer,0,0,0,255);
+                    SDL_RenderDrawRect(renderer,&cell);
+                    SDL_SetRenderDrawColor(renderer,rcol,gcol,bcol,255);
+                }
+            }
+
+    // Aperçu des prochaines pièces, à droite de la grille (cases deux fois plus petites)
+    float mini=tile/2.0f;
+    for(int i=0;i<PREVIEW_COUNT;i++){
+        float px=offsetX+GRID_WIDTH*tile+mini;
+        float py=offsetY+2*tile+i*3*mini;
+        SDL_SetRenderDrawColor(renderer,180,180,180,255);
+        for(int y=0;y<4;y++)
+            for(int x=0;x<4;x++)
+                if(pieceCell(snap->next[i],0,x,y)){
+                    SDL_Rect cell={ (int)(px+x*mini), (int)(py+y*mini), (int)(mini+0.5f), (int)(mini+0.5f) };
+                    SDL_RenderFillRect(renderer,&cell);
+                    SDL_SetRenderDrawColor(renderer,0,0,0,255);
+                    SDL_RenderDrawRect(renderer,&cell);
+                    SDL_SetRenderDrawColor(renderer,180,180,180,255);
+                }
+    }
+
+    // Affiche le score pendant la partie (TTF)
+    drawScore(renderer, winW, winH, snap->score);
+}
+
 // ------------------------------------------------------------
 // ------------------------------ MAIN -------------------------
 // ------------------------------------------------------------
 int main(int argc,char *argv[]){
-    srand((unsigned)time(NULL)); //initialise le générateur de nombres aléatoires pour faire des pièces aléatoire + couleurs
+    init_piece_cells();
+
+    // options communes : tampon audio (plus petit = effets entendus plus tôt),
+    // graine et mode du générateur de pièces (séquences reproductibles)
+    Uint64 seed = (Uint64)time(NULL);
+    int genMode = GEN_RANDOM;
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i],"--audio-buffer")==0 && i+1<argc) gAudioBuffer = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--seed")==0 && i+1<argc) seed = strtoull(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--bag")==0) genMode = GEN_BAG;
+        else if(strcmp(argv[i],"--random")==0) genMode = GEN_RANDOM;
+    }
+    if(gAudioBuffer < 64 || gAudioBuffer > 8192){
+        printf("Erreur : --audio-buffer doit être entre 64 et 8192 échantillons\n");
+        return 2;
+    }
+
+    // modes outils en ligne de commande (sans fenêtre)
+    if(argc>1 && strcmp(argv[1],"--solve")==0) return solver_main(argc,argv);
+    if(argc>1 && strcmp(argv[1],"--bench-solver")==0) return solver_bench();
+    if(argc>1 && strcmp(argv[1],"--sfx-latency")==0) return sfx_latency_main();
+    if(argc>1 && strcmp(argv[1],"--bench-gen")==0) return gen_bench(genMode,seed);
+
+    srand((unsigned)time(NULL)); //initialise le générateur de nombres aléatoires (scintillement du menu ; les pièces ont leur propre générateur)
 
     // --------------------
     // SDL INIT + SDL_MIXER + TTF
@@ -568,10 +1506,11 @@ int main(int argc,char *argv[]){
         printf("Warning: Mix_Init failed for MP3: %s\n", Mix_GetError());
     }
 
-    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0){ //configure l'audio avec fréquence=44100 Hz, stéréo (2)(ce choix car son plus réaliste gauche droite), buffer = 2048 (stocke le son avant de l'envoyer aux haut-parleurs)
+    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, gAudioBuffer) < 0){ //configure l'audio avec fréquence=44100 Hz, stéréo (2)(ce choix car son plus réaliste gauche droite), buffer = gAudioBuffer échantillons (512 par défaut, ~12 ms : stocke le son avant de l'envoyer aux haut-parleurs)
         printf("Erreur audio (Mix_OpenAudio) : %s\n", Mix_GetError());
         // On continue sans son si impossible
     }
+    sfx_init(); //prépare les effets sonores une fois pour toutes
 
     gMusic = Mix_LoadMUS("tetris.mp3"); //charge la musique de fond
     if(!gMusic){
@@ -587,6 +1526,7 @@ int main(int argc,char *argv[]){
     if(!window){ //si la fenêtre n'est pas crée on fait un nettoyage complet (musique, audio, police et SDL) + on sort du programme
         printf("Erreur fenetre: %s\n", SDL_GetError());
         if(gMusic) Mix_FreeMusic(gMusic);
+        sfx_free();
         Mix_CloseAudio();
         Mix_Quit();
         if(gFont) TTF_CloseFont(gFont);
@@ -600,6 +1540,7 @@ int main(int argc,char *argv[]){
         printf("Erreur renderer: %s\n", SDL_GetError());
         SDL_DestroyWindow(window);
         if(gMusic) Mix_FreeMusic(gMusic);
+        sfx_free();
         Mix_CloseAudio();
         Mix_Quit();
         if(gFont) TTF_CloseFont(gFont);
@@ -614,126 +1555,79 @@ int main(int argc,char *argv[]){
     menu(window, renderer, winW, winH);  // affiche le menu principal + attend que le joueur clique sur play 
     ask_player_name(window, renderer); //demande le nom du joueur et le stocke dans playerName 
     memset(grid,0,sizeof(grid)); //mets toute la grille à zéro et vide le plateau 
-    spawn_new_piece(renderer,winW,winH); //génère la première pièce et vérifie le game over immédiat
+    gen_init(&gGen, genMode, seed); //générateur de pièces (--seed / --bag)
+    int alive = spawn_new_piece(); //génère la première pièce et vérifie le game over immédiat
+
+    // la simulation tourne sur son propre thread : on lui publie l'état de départ puis on la lance
+    triple_buffer_init(&gSnapshots);
+    publish_snapshot(&gSnapshots, !alive);
+    SDL_AtomicSet(&gSimQuit, !alive);
+    SDL_Thread *simThread = SDL_CreateThread(simulation_thread, "simulation", NULL);
+    if(!simThread){
+        printf("Erreur SDL_CreateThread : %s\n", SDL_GetError());
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        if(gMusic) Mix_FreeMusic(gMusic);
+        sfx_free();
+        Mix_CloseAudio();
+        Mix_Quit();
+        if(gFont) TTF_CloseFont(gFont);
+        TTF_Quit();
+        SDL_Quit();
+        return 1;
+    }
 
-    Uint32 lastFall=SDL_GetTicks(); //sauegarde le temps actuel (en ms), sert à calculer la vitesse de chute 
     int quit=0; // condition de sortie 
     SDL_Event e; //évenements clavier / souris 
 
+    // Le thread principal lit les événements et dessine (l'API de rendu SDL
+    // n'est utilisable que depuis ce thread). La gravité tourne sur le thread
+    // de simulation, donc une image lente ne la retarde pas ; les touches
+    // peuvent arriver en retard mais gardent leur e.key.timestamp (posé quand
+    // ce thread récupère les événements), ce qui permet à la simulation de
+    // les ordonner correctement par rapport à la gravité.
     while(!quit){ //s'execute tant que le joueur ne quitte pas 
         SDL_GetWindowSize(window,&winW,&winH); // permet un rendu adaptatif
 
-        while(SDL_PollEvent(&e)){ //récupère tous les événements SDL
-            if(e.type==SDL_QUIT){ quit=1; break; } //clic sue la croix : sortie 
+        while(SDL_PollEvent(&e)){ //récupère tous les événements SDL et les transmet à la simulation
+            if(e.type==SDL_QUIT){ quit=1; break; } //clic sur la croix : sortie 
 
             if(e.type==SDL_KEYDOWN){ //détecte une touche pressée
+                Uint32 t = e.key.timestamp; // instant de la touche : la simulation l'ordonne par rapport à la gravité
                 switch(e.key.keysym.sym){
-                    case SDLK_LEFT: // gauche : déplacement si collision 
-                        if(!collision_at(pieceX-1,pieceY,pieceRot)) pieceX--;
-                        break;
-
-                    case SDLK_RIGHT: //droite : déplacement si collision 
-                        if(!collision_at(pieceX+1,pieceY,pieceRot)) pieceX++;
-                        break;
-
-                    case SDLK_DOWN: //bas : déplacement si collision 
-                        if(!collision_at(pieceX,pieceY+1,pieceRot)) pieceY++;
-                        break;
-
-                    case SDLK_UP: //haut : rotation avec correction murale 
-                        try_rotate_with_kick(winW,winH,renderer);
-                        break;
-
-                    case SDLK_SPACE: //chute instantanée puis verrouillage + nouvelle pièce 
-                        while(!collision_at(pieceX,pieceY+1,pieceRot)) pieceY++;
-                        lockPiece();
-                        clearLines();
-                        spawn_new_piece(renderer,winW,winH);
-                        lastFall=SDL_GetTicks();
-                        break;
+                    case SDLK_LEFT:  input_push(&gInput, INPUT_LEFT, t);   break; // gauche
+                    case SDLK_RIGHT: input_push(&gInput, INPUT_RIGHT, t);  break; // droite
+                    case SDLK_DOWN:  input_push(&gInput, INPUT_DOWN, t);   break; // bas
+                    case SDLK_UP:    input_push(&gInput, INPUT_ROTATE, t); break; // haut : rotation avec correction murale
+                    case SDLK_SPACE: input_push(&gInput, INPUT_DROP, t);   break; // chute instantanée
                 }
             }
         }
-        int fallDelay = 500 - (score / 500) * 50; // chaque fois  qu'il y a 500 points on augmente la vitesse de 100ms 
-        if (fallDelay < 100) fallDelay = 100;  // limite minimale : 100ms
-
-        if(SDL_GetTicks()-lastFall>fallDelay){   // definir le temps que les pièces descendent / si assez de temps écoulé : pièce descend ou se verrouille
-            if(!collision_at(pieceX,pieceY+1,pieceRot)) pieceY++; 
-            else{
-                lockPiece();
-                clearLines();
-                spawn_new_piece(renderer,winW,winH);
-            }
-            lastFall=SDL_GetTicks();
-        }
-
-        float tile=(winH/(float)GRID_HEIGHT < winW/(float)GRID_WIDTH)? winH/(float)GRID_HEIGHT : winW/(float)GRID_WIDTH; // calcule la taille d'une case / s'adapte à la fenêtre 
-
-        float offsetX=(winW - tile*GRID_WIDTH)/2.0f; //centre la grille 
-        float offsetY=(winH - tile*GRID_HEIGHT)/2.0f;
 
-        SDL_SetRenderDrawColor(renderer,0,0,0,255); // couleur de fond
-        SDL_RenderClear(renderer); //efface l'écran avec la couleur définie juste avant
-
-        // Grille
-        for(int gy=0; gy<GRID_HEIGHT; gy++){
-            for(int gx=0; gx<GRID_WIDTH; gx++){
-                SDL_Rect cell={
-                    (int)(offsetX+gx*tile),
-                    (int)(offsetY+gy*tile),
-                    (int)(tile+0.5f),
-                    (int)(tile+0.5f)
-                };
-
-                if(grid[gy][gx]){
-                    int packed=grid[gy][gx];
-                    int r=(packed>>16)&0xFF, g=(packed>>8)&0xFF, b=packed&0xFF;
-                    SDL_SetRenderDrawColor(renderer,r,g,b,255); //couleur aléatoire pour les pièces 
-                    SDL_RenderFillRect(renderer,&cell); //dessine un rectangle plein à la position et taille décrites par cell
-
-                    // dessine une bordure fine autour du bloc
-                    SDL_SetRenderDrawColor(renderer,0,0,0,200);
-                    SDL_RenderDrawRect(renderer,&cell);
-                } else {
-                    SDL_SetRenderDrawColor(renderer,50,50,50,255);
-                    SDL_RenderDrawRect(renderer,&cell);
-                }
-            }
+        const BoardSnapshot *snap = acquire_snapshot(&gSnapshots); // dernier état complet publié par la simulation
+        if(snap->gameOver){
+            SDL_WaitThread(simThread, NULL); // la simulation s'est arrêtée d'elle-même
+            simThread = NULL;
+            afficher_game_over(renderer,winW,winH);
+            break;
         }
 
-        // Pièce active
-        int rcol=pieceColor[0], gcol=pieceColor[1], bcol=pieceColor[2];
-        SDL_SetRenderDrawColor(renderer,rcol,gcol,bcol,255);
-
-        for(int y=0;y<4;y++)
-            for(int x=0;x<4;x++)
-                if(pieceCell(currentPiece,pieceRot,x,y)){
-                    int gx=pieceX+x, gy=pieceY+y;
-                    // only draw visible cells (gy might be negative)
-                    if(gy >= 0 && gy < GRID_HEIGHT){
-                        SDL_Rect cell={
-                            (int)(offsetX+gx*tile),
-                            (int)(offsetY+gy*tile),
-                            (int)(tile+0.5f),
-                            (int)(tile+0.5f)
-                        };
-                        SDL_RenderFillRect(renderer,&cell);
-                        SDL_SetRenderDrawColor(renderer,0,0,0,255);
-                        SDL_RenderDrawRect(renderer,&cell);
-                        SDL_SetRenderDrawColor(renderer,rcol,gcol,bcol,255);
-                    }
-                }
-
-        // Affiche le score pendant la partie (TTF)
-        drawScore(renderer, winW, winH); 
-
+        draw_game(renderer,winW,winH,snap);
         SDL_RenderPresent(renderer); //affiche tout l'écran 
         SDL_Delay(8); //petite pause pour stabiliser le framerate (nombre d'images affichées par seconde)
     }
 
+    // arrêt du thread de simulation avant de libérer quoi que ce soit
+    if(simThread){
+        SDL_AtomicSet(&gSimQuit, 1);
+        SDL_WaitThread(simThread, NULL);
+    }
+
     // Nettoyage audio + ttf
     if(gMusic) Mix_FreeMusic(gMusic);
+    sfx_free();
     Mix_CloseAudio();
+    sfx_report();
     Mix_Quit();
 
     if(gFont) TTF_CloseFont(gFont);